@@ -0,0 +1,56 @@
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <charconv>
+
+#include "games/connect_four/analysis.h"
+
+int main(int argc, char** argv)
+{
+    uint32_t threads = std::thread::hardware_concurrency();
+
+    bool valid = argc == 3 || argc == 4;
+
+    if (argc == 4)
+    {
+        const char* end = argv[3] + std::strlen(argv[3]);
+
+        auto [parsed, error] = std::from_chars(argv[3], end, threads);
+
+        valid = error == std::errc() && parsed == end && threads > 0;
+    }
+
+    if (!valid)
+    {
+        std::cerr << "usage: " << argv[0] << " <games_file> <summary_file> [threads]" << std::endl;
+
+        return 1;
+    }
+
+    std::ifstream input(argv[1]);
+    std::ofstream output(argv[2]);
+
+    if (!input || !output)
+    {
+        std::cerr << "unable to open " << (!input ? argv[1] : argv[2]) << std::endl;
+
+        return 1;
+    }
+
+    auto table = connect_four::TranspositionTable(22);
+
+    auto report = connect_four::analyse_logs(input, output, table, threads);
+
+    std::cout << report.games << " games (" << report.invalid << " invalid), "
+              << report.positions << " positions in " << report.seconds << "s, "
+              << static_cast<uint64_t>(report.positions_per_second()) << " positions/s" << std::endl;
+
+#ifdef AIGAMES_TRACE
+    auto trace_path = std::string(argv[2]) + ".trace.json";
+
+    if (!trace::dump(trace_path.c_str())) std::cerr << "unable to write trace to " << trace_path << std::endl;
+#endif
+
+    return 0;
+}
@@ -6,10 +6,12 @@
 #define AIGAMES__GAME_H
 
 #include <chrono>
+#include <string>
 #include "raylib.h"
 
 #include "nml/primitives/span.h"
 
+#include "trace.h"
 #include "connect_four/agent.h"
 #include "connect_four/render.h"
 
@@ -27,10 +29,15 @@ namespace connect_four
     public:
         explicit ConnectFour() noexcept;
 
+        void unload() noexcept;
         void draw_frame() noexcept;
         void seed(Span<const uint8_t> moves) noexcept;
 
         RenderState& get_state() noexcept { return _state; };
+
+    private:
+
+        static bool is_key_pressed() noexcept;
     };
 
     inline static void play() noexcept
@@ -47,15 +54,38 @@ namespace connect_four
 
         SetTargetFPS(state.fps);
 
+        bool idle = false;
+
         while (!WindowShouldClose())
         {
+            if (idle != state.is_idle())
+            {
+                idle = !idle;
+
+                SetTargetFPS(idle ? state.idle_fps : state.fps);
+            }
+
             BeginDrawing();
 
             game.draw_frame();
 
             EndDrawing();
+
+#ifdef AIGAMES_TRACE
+            if (IsKeyPressed(KEY_F12))
+            {
+                auto trace_path = std::string(GetApplicationDirectory()) + "connect_four_trace.json";
+
+                if (trace::dump(trace_path.c_str())) TraceLog(LOG_INFO, "Trace written to %s", trace_path.c_str());
+                else TraceLog(LOG_WARNING, "Trace could not be written to %s", trace_path.c_str());
+            }
+#endif
         }
 
+        game.unload();
+
+        state.cache_save();
+
         CloseWindow();
     }
 
@@ -69,8 +99,27 @@ namespace connect_four
         _state.board.seed(moves);
     }
 
+    void ConnectFour::unload() noexcept
+    {
+        _board.unload();
+    }
+
+    // Polls every key rather than calling GetKeyPressed(), which pops raylib's key queue and would steal presses
+    // from anything else reading it.
+    bool ConnectFour::is_key_pressed() noexcept
+    {
+        for (int key = KEY_SPACE; key <= KEY_KB_MENU; ++key)
+        {
+            if (IsKeyPressed(key)) return true;
+        }
+
+        return false;
+    }
+
     void ConnectFour::draw_frame() noexcept
     {
+        TRACE_SCOPE("frame");
+
         _state.is_hovering = false;
         _state.is_left_click = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
 
@@ -80,9 +129,21 @@ namespace connect_four
 
         _state.mouse_location = GetMousePosition();
 
+        Vector2 mouse_delta = GetMouseDelta();
+
+        bool is_active = _state.is_left_click || IsWindowResized() || is_key_pressed()
+            || mouse_delta.x != 0 || mouse_delta.y != 0 || GetMouseWheelMove() != 0;
+
+        if (is_active) _state.active_frame = _state.frame;
+
         ClearBackground(_state.colors.background);
 
-        _board.draw();
+        {
+            TRACE_SCOPE("board");
+
+            _board.draw();
+        }
+
         _header.draw();
         _winner.draw();
 
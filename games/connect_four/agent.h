@@ -5,49 +5,191 @@
 #ifndef AIGAMES_AGENT_H
 #define AIGAMES_AGENT_H
 
+#include <algorithm>
+
 #include "state.h"
+#include "transposition.h"
+
+#include "../trace.h"
 
 #include "nml/primitives/span.h"
 #include "nml/primitives/list.h"
 
 namespace connect_four
 {
+    // Each technique can be switched off on its own so their node and time savings can be measured in isolation.
+    struct SearchConfig
+    {
+        uint8_t depth = 10;
+
+        bool iterative_deepening = true;
+        bool killer_moves = true;
+        bool history = true;
+        bool aspiration_windows = true;
+        bool late_move_reductions = true;
+
+        int32_t aspiration_window = 16;
+        uint8_t aspiration_widenings = 2;
+
+        uint8_t reduction = 1;
+        uint8_t reduction_min_depth = 3;
+        uint8_t reduction_move_index = 3;
+    };
+
     class MinimaxAgent
     {
+        constexpr static int32_t INFINITE = 1e9;
+        constexpr static uint8_t MAX_PLY = BoardState::ROWS * BoardState::COLUMNS + 1;
+        constexpr static uint8_t CELLS = BoardState::COLUMNS * (BoardState::ROWS + 1);
+
         BoardState& _state;
+        TranspositionTable* _table;
+        SearchConfig _config;
+
         uint8_t _column = 0;
+        int32_t _score = 0;
+        uint64_t _nodes = 0;
+
+#ifdef AIGAMES_TRACE
+        uint64_t _probes = 0;
+        uint64_t _evaluations = 0;
+#endif
 
-        constexpr static uint8_t MAX_DEPTH = 10;
+        uint8_t _killers[MAX_PLY][2];
+        uint32_t _history[2][CELLS]{};
 
     public:
 
-        explicit MinimaxAgent(BoardState& state)
-            : _state(state)
-        { }
+        explicit MinimaxAgent(BoardState& state, TranspositionTable* table = nullptr, SearchConfig config = {})
+            : _state(state), _table(table), _config(config)
+        {
+            _config.depth = std::clamp<uint8_t>(_config.depth, 1, MAX_PLY - 1);
+
+            for (auto& killers : _killers) killers[0] = killers[1] = BoardState::COLUMNS;
+        }
 
         uint8_t next_move() noexcept;
+        int32_t evaluate(uint8_t column) noexcept;
+
+        [[nodiscard]] int32_t score() const noexcept { return _score; }
+        [[nodiscard]] uint64_t nodes() const noexcept { return _nodes; }
+        [[nodiscard]] const SearchConfig& config() const noexcept { return _config; }
 
     private:
 
-        int32_t principal_variation(int32_t alpha, int32_t beta, uint8_t depth) noexcept;
+        void reset_ordering() noexcept;
+        int32_t search_root(uint8_t depth, bool aspirate, int32_t center) noexcept;
+        uint8_t order_moves(uint8_t* columns, uint8_t hash_column, uint8_t ply) const noexcept;
+        void record_cutoff(uint8_t column, uint8_t ply, uint8_t depth) noexcept;
+
+        int32_t principal_variation(int32_t alpha, int32_t beta, uint8_t depth, uint8_t ply) noexcept;
+
+        [[nodiscard]] uint8_t cell(uint8_t column) const noexcept { return column * (BoardState::ROWS + 1) + _state.column_height(column); }
     };
 
     uint8_t MinimaxAgent::next_move() noexcept
     {
-        uint32_t score = principal_variation(-1e9, 1e9, MAX_DEPTH);
+        TRACE_SCOPE("next_move");
+
+        _nodes = 0;
+
+        TRACE_RESET(_probes);
+        TRACE_RESET(_evaluations);
+
+        reset_ordering();
+
+        uint8_t first = _config.iterative_deepening ? 1 : _config.depth;
+
+        // The evaluation swings between odd and even depths, so each window is centred on the last score of the
+        // same parity rather than the previous iteration's.
+        int32_t scores[2] = {};
+
+        for (uint8_t depth = first; depth <= _config.depth; ++depth)
+        {
+            TRACE_SCOPE("search_iteration");
+
+            _score = scores[depth % 2] = search_root(depth, _config.aspiration_windows && depth > first + 1, scores[depth % 2]);
+
+            TRACE_COUNTER("nodes", _nodes);
+            TRACE_COUNTER("tt_probes", _probes);
+            TRACE_COUNTER("evaluations", _evaluations);
+        }
 
         return _column;
     }
 
-    int32_t MinimaxAgent::principal_variation(int32_t alpha, int32_t beta, uint8_t depth) noexcept
+    int32_t MinimaxAgent::evaluate(uint8_t column) noexcept
     {
-        if (_state.has_winner()) return -(_state.ROWS * _state.COLUMNS + depth - MAX_DEPTH);
+        _state.push(column);
 
-        if (_state.is_tie()) return 0;
+        int32_t score = -principal_variation(-INFINITE, INFINITE, _config.depth - 1, 1);
+
+        _state.pop(column);
+
+        return score;
+    }
+
+    // Searches a window around center, widening only the side that failed by a growing margin, and falls back to
+    // the full window once the configured widenings are used up.
+    int32_t MinimaxAgent::search_root(uint8_t depth, bool aspirate, int32_t center) noexcept
+    {
+        if (!aspirate) return principal_variation(-INFINITE, INFINITE, depth, 0);
+
+        int32_t delta = _config.aspiration_window;
+        int32_t alpha = center - delta, beta = center + delta;
+
+        for (uint8_t widening = 0;; ++widening)
+        {
+            uint8_t column = _column;
+
+            int32_t score = principal_variation(alpha, beta, depth, 0);
+
+            bool fail_low = score <= alpha && alpha != -INFINITE;
+            bool fail_high = score >= beta && beta != INFINITE;
+
+            if (!fail_low && !fail_high) return score;
+
+            delta *= 4;
+
+            bool exhausted = widening >= _config.aspiration_widenings;
+
+            if (fail_low)
+            {
+                _column = column;
+
+                alpha = exhausted ? -INFINITE : score - delta;
+            }
+            else
+            {
+                beta = exhausted ? INFINITE : score + delta;
+            }
+        }
+    }
+
+    void MinimaxAgent::reset_ordering() noexcept
+    {
+        for (auto& killers : _killers) killers[0] = killers[1] = BoardState::COLUMNS;
+
+        for (auto& side : _history) for (uint32_t& score : side) score >>= 1;
+    }
+
+    // Fills columns with the legal moves center-out, then brings the hash move, killers and history to the front.
+    // This runs at every interior node, so the at most seven moves are insertion sorted in place rather than
+    // through std::stable_sort, which allocates a temporary buffer per call.
+    uint8_t MinimaxAgent::order_moves(uint8_t* columns, uint8_t hash_column, uint8_t ply) const noexcept
+    {
+        auto priority = [&](uint8_t column) -> uint64_t
+        {
+            if (column == hash_column) return UINT64_MAX;
 
-        if (depth == 0) return _state.score();
+            if (_config.killer_moves && column == _killers[ply][0]) return UINT64_MAX - 1;
+            if (_config.killer_moves && column == _killers[ply][1]) return UINT64_MAX - 2;
 
-        int score = 0; bool solved = false;
+            return _config.history ? _history[_state.turn_player_one][cell(column)] : 0;
+        };
+
+        uint8_t count = 0;
+        uint64_t priorities[BoardState::COLUMNS];
 
         for (uint8_t distance = 0; distance <= _state.COLUMNS / 2; ++distance)
         {
@@ -55,35 +197,129 @@ namespace connect_four
             {
                 if (!_state.can_push(column)) continue;
 
-                _state.push(column);
+                uint64_t column_priority = priority(column);
 
-                if (solved)
-                {
-                    score = -principal_variation(-alpha - 1, -alpha, depth - 1);
+                uint8_t index = count++;
 
-                    if (alpha < score && beta > score)
-                    {
-                        score = -principal_variation(-beta, -alpha, depth - 1);
-                    }
-                }
-                else
+                for (; index > 0 && priorities[index - 1] < column_priority; --index)
                 {
-                    score = -principal_variation(-beta, -alpha, depth - 1);
+                    columns[index] = columns[index - 1];
+                    priorities[index] = priorities[index - 1];
                 }
 
-                _state.pop(column);
+                columns[index] = column;
+                priorities[index] = column_priority;
+            }
+        }
+
+        return count;
+    }
+
+    void MinimaxAgent::record_cutoff(uint8_t column, uint8_t ply, uint8_t depth) noexcept
+    {
+        if (_config.killer_moves && _killers[ply][0] != column)
+        {
+            _killers[ply][1] = _killers[ply][0];
+            _killers[ply][0] = column;
+        }
+
+        if (_config.history) _history[_state.turn_player_one][cell(column)] += depth * depth;
+    }
+
+    int32_t MinimaxAgent::principal_variation(int32_t alpha, int32_t beta, uint8_t depth, uint8_t ply) noexcept
+    {
+        _nodes++;
+
+        if (_state.has_winner()) return -(_state.ROWS * _state.COLUMNS + 1 - _state.moves_played);
+
+        if (_state.is_tie()) return 0;
+
+        if (depth == 0)
+        {
+            TRACE_INCREMENT(_evaluations);
+
+            return _state.score();
+        }
+
+        TranspositionEntry entry;
+
+        uint8_t hash_column = _state.COLUMNS;
+
+        if (_table) TRACE_INCREMENT(_probes);
+
+        if (_table && _table->probe(_state.key(), entry))
+        {
+            hash_column = entry.column;
+
+            if (ply != 0 && entry.depth >= depth)
+            {
+                if (entry.bound == Bound::EXACT) return std::min(std::max(entry.score, alpha), beta);
+                if (entry.bound == Bound::LOWER && beta <= entry.score) return beta;
+                if (entry.bound == Bound::UPPER && entry.score <= alpha) return alpha;
+            }
+        }
+
+        uint8_t columns[BoardState::COLUMNS];
+        uint8_t count = order_moves(columns, hash_column, ply);
+
+        int score = 0; bool solved = false; uint8_t best = _state.COLUMNS;
+
+        for (uint8_t index = 0; index < count; ++index)
+        {
+            uint8_t column = columns[index];
 
-                if (beta <= score) return beta;
+            bool quiet = column != hash_column && column != _killers[ply][0] && column != _killers[ply][1];
 
-                if (alpha < score)
+            _state.push(column);
+
+            if (solved)
+            {
+                // Root moves are never reduced, so the reported best move and score come from full-depth searches.
+                bool reduce = _config.late_move_reductions && quiet && ply != 0
+                    && depth >= _config.reduction_min_depth && index >= _config.reduction_move_index;
+
+                uint8_t reduction = reduce ? std::min<uint8_t>(_config.reduction, depth - 1) : 0;
+
+                score = -principal_variation(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+
+                if (reduction && alpha < score)
                 {
-                    alpha = score, solved = true;
+                    score = -principal_variation(-alpha - 1, -alpha, depth - 1, ply + 1);
+                }
 
-                    if (depth == MAX_DEPTH) _column = column;
+                if (alpha < score && beta > score)
+                {
+                    score = -principal_variation(-beta, -alpha, depth - 1, ply + 1);
                 }
             }
+            else
+            {
+                score = -principal_variation(-beta, -alpha, depth - 1, ply + 1);
+            }
+
+            _state.pop(column);
+
+            if (beta <= score)
+            {
+                if (quiet) record_cutoff(column, ply, depth);
+
+                if (_table) _table->store(_state.key(), { beta, depth, column, Bound::LOWER });
+
+                if (ply == 0) _column = column;
+
+                return beta;
+            }
+
+            if (alpha < score)
+            {
+                alpha = score, solved = true, best = column;
+
+                if (ply == 0) _column = column;
+            }
         }
 
+        if (_table) _table->store(_state.key(), { alpha, depth, best, solved ? Bound::EXACT : Bound::UPPER });
+
         return alpha;
     }
 }
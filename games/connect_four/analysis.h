@@ -0,0 +1,215 @@
+#ifndef AIGAMES_ANALYSIS_H
+#define AIGAMES_ANALYSIS_H
+
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <string_view>
+
+#include "state.h"
+#include "agent.h"
+#include "transposition.h"
+
+namespace connect_four
+{
+    struct MoveAnnotation
+    {
+        uint8_t played = 0;
+        uint8_t best = 0;
+        int32_t eval = 0;
+        int32_t error = 0;
+    };
+
+    struct AnalysisReport
+    {
+        uint64_t games = 0;
+        uint64_t invalid = 0;
+        uint64_t positions = 0;
+        double seconds = 0;
+
+        [[nodiscard]] double positions_per_second() const noexcept { return seconds > 0 ? positions / seconds : 0; }
+    };
+
+    // Replays a single game log on its own board and agent; the table is shared with every other analyser.
+    // Late-move reductions are off by default because annotations compare scores across moves, and a reduced
+    // search can rank a worse move above a better one.
+    class GameAnalyser
+    {
+        BoardState _state;
+        MinimaxAgent _agent;
+
+    public:
+
+        explicit GameAnalyser(TranspositionTable& table, SearchConfig config = { .late_move_reductions = false })
+            : _state(), _agent(_state, &table, config)
+        { }
+
+        bool analyse(const std::vector<uint8_t>& moves, std::vector<MoveAnnotation>& annotations) noexcept;
+    };
+
+    // Moves are column digits in the order `BoardState::seed` takes them, one game per line; separators are ignored.
+    bool parse_game(std::string_view line, std::vector<uint8_t>& moves) noexcept
+    {
+        moves.clear();
+
+        for (char character : line)
+        {
+            if (character == ',' || character == ' ' || character == '\t' || character == '\r') continue;
+
+            if (character < '0' || character >= '0' + BoardState::COLUMNS) return false;
+
+            moves.push_back(character - '0');
+        }
+
+        return !moves.empty();
+    }
+
+    bool GameAnalyser::analyse(const std::vector<uint8_t>& moves, std::vector<MoveAnnotation>& annotations) noexcept
+    {
+        TRACE_SCOPE("analyse_game");
+
+        _state.reset();
+        _state.turn_player_one = true;
+
+        annotations.clear();
+
+        for (uint8_t column : moves)
+        {
+            if (_state.has_winner() || !_state.can_push(column)) return false;
+
+            MoveAnnotation annotation{ .played = column };
+
+            annotation.best = _agent.next_move();
+            annotation.eval = _agent.score();
+
+            if (annotation.best != column)
+            {
+                annotation.error = std::max(0, annotation.eval - _agent.evaluate(column));
+            }
+
+            annotations.push_back(annotation);
+
+            _state.push(column);
+        }
+
+        return true;
+    }
+
+    static void write_annotations(std::string& out, uint64_t index, bool valid, const std::vector<MoveAnnotation>& annotations)
+    {
+        out += std::to_string(index);
+
+        if (!valid)
+        {
+            out += "\tinvalid\n"; return;
+        }
+
+        int32_t total_error = 0, max_error = 0;
+
+        for (auto& annotation : annotations)
+        {
+            total_error += annotation.error;
+            max_error = std::max(max_error, annotation.error);
+        }
+
+        out += '\t' + std::to_string(annotations.size());
+        out += '\t' + std::to_string(total_error);
+        out += '\t' + std::to_string(max_error) + '\t';
+
+        for (auto& annotation : annotations)
+        {
+            out += std::to_string(annotation.played) + '/' + std::to_string(annotation.best) + '/';
+            out += std::to_string(annotation.eval) + '/' + std::to_string(annotation.error) + ' ';
+        }
+
+        out.back() = '\n';
+    }
+
+    // Streams game logs from input in batches so memory stays flat regardless of file size. Each worker owns an
+    // analyser, all of them share the table, and one line per game is written to output as `index plies total_error
+    // max_error played/best/eval/error...`; output order follows completion, not input order.
+    AnalysisReport analyse_logs(std::istream& input, std::ostream& output, TranspositionTable& table, uint32_t threads)
+    {
+        constexpr static uint32_t BATCH_SIZE = 64;
+
+        std::mutex input_lock, output_lock;
+
+        uint64_t next_index = 0;
+        AnalysisReport report;
+
+        auto start = std::chrono::steady_clock::now();
+
+        auto worker = [&]()
+        {
+            GameAnalyser analyser(table);
+
+            std::string out;
+            std::vector<uint8_t> moves;
+            std::vector<std::string> lines;
+            std::vector<MoveAnnotation> annotations;
+
+            AnalysisReport local;
+
+            while (true)
+            {
+                uint64_t first_index;
+
+                {
+                    std::lock_guard lock(input_lock);
+
+                    lines.resize(BATCH_SIZE);
+
+                    uint32_t count = 0;
+
+                    while (count < BATCH_SIZE && std::getline(input, lines[count])) count++;
+
+                    lines.resize(count);
+
+                    first_index = next_index;
+                    next_index += count;
+                }
+
+                if (lines.empty()) break;
+
+                out.clear();
+
+                for (uint32_t offset = 0; offset < lines.size(); ++offset)
+                {
+                    bool valid = parse_game(lines[offset], moves) && analyser.analyse(moves, annotations);
+
+                    local.games++;
+                    local.invalid += !valid;
+                    local.positions += valid ? annotations.size() : 0;
+
+                    write_annotations(out, first_index + offset, valid, annotations);
+                }
+
+                std::lock_guard lock(output_lock);
+
+                output << out;
+            }
+
+            std::lock_guard lock(output_lock);
+
+            report.games += local.games;
+            report.invalid += local.invalid;
+            report.positions += local.positions;
+        };
+
+        std::vector<std::thread> workers;
+
+        for (uint32_t thread = 0; thread < std::max(threads, 1u); ++thread) workers.emplace_back(worker);
+
+        for (auto& thread : workers) thread.join();
+
+        report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        return report;
+    }
+}
+
+#endif //AIGAMES_ANALYSIS_H
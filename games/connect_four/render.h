@@ -5,9 +5,13 @@
 #ifndef AIGAMES_RENDER_H
 #define AIGAMES_RENDER_H
 
+#include <string>
+#include <filesystem>
+
 #include "state.h"
 
 #include "raylib.h"
+#include "../trace.h"
 #include "nml/external/date.h"
 
 namespace connect_four
@@ -36,7 +40,9 @@ namespace connect_four
         ColorsScheme colors{};
 
         int32_t fps = 30;
+        int32_t idle_fps = 5;
         uint64_t frame = 0;
+        uint64_t active_frame = 0;
         DateTime start_time = Clock::now();
 
         int32_t window_width = 0;
@@ -50,19 +56,28 @@ namespace connect_four
 
         Score score;
         BoardState board;
+        std::string cache_path;
+        TranspositionTable table;
         MinimaxAgent agent;
 
+        bool is_cache_dirty = false;
+
         uint64_t win_frame = 0;
         Winner winner = Winner::NONE;
 
-        explicit RenderState() noexcept
-            : score(), board(), agent(board)
-        { }
+        explicit RenderState(std::string cache_file = std::string(GetApplicationDirectory()) + "connect_four_cache.bin") noexcept
+            : score(), board(), cache_path(std::move(cache_file)), table(20, cache_path.c_str()), agent(board, &table)
+        {
+            if (table.is_restored()) TraceLog(LOG_INFO, "Search cache restored from %s", cache_path.c_str());
+            else if (std::filesystem::exists(cache_path)) TraceLog(LOG_WARNING, "Search cache %s is stale or corrupt, ignored", cache_path.c_str());
+        }
 
+        void cache_save();
         void board_reset();
         void winner_declare(Winner winner);
         void emplace(uint8_t column) noexcept;
         [[nodiscard]] bool is_playing() const { return winner == Winner::NONE; }
+        [[nodiscard]] bool is_idle() const { return active_frame + fps < frame && (is_playing() || win_frame + fps < frame); }
     };
 
     void RenderState::winner_declare(Winner winner_game)
@@ -76,6 +91,14 @@ namespace connect_four
         score.player_two += winner_game == Winner::PLAYER_TWO;
     }
 
+    void RenderState::cache_save()
+    {
+        if (!is_cache_dirty) return;
+
+        if (table.save(cache_path.c_str())) is_cache_dirty = false;
+        else TraceLog(LOG_WARNING, "Search cache could not be saved to %s", cache_path.c_str());
+    }
+
     void RenderState::board_reset()
     {
         board.reset();
@@ -84,11 +107,15 @@ namespace connect_four
         if (!board.turn_player_one)
         {
             board.push(agent.next_move());
+
+            is_cache_dirty = true;
         }
     }
 
     void RenderState::emplace(uint8_t column) noexcept
     {
+        TRACE_SCOPE("emplace");
+
         if (winner == Winner::NONE && !board.can_push(column)) return;
 
         board.push(column);
@@ -101,6 +128,8 @@ namespace connect_four
         {
             board.push(agent.next_move());
 
+            is_cache_dirty = true;
+
             if (board.has_winner())
             {
                 winner_declare(board.turn_player_one ? Winner::PLAYER_TWO : Winner::PLAYER_ONE);
@@ -196,7 +225,16 @@ namespace connect_four
     {
         RenderState& _state;
 
-        struct BoardLocation { uint8_t row; uint8_t column; };
+        // The board and placed discs only change on a push, a reset or a resize, so they are drawn once into a
+        // texture and blitted every frame; the key below is what they were last drawn from. Render textures are not
+        // multisampled, so the cache is drawn at twice the size and filtered down in place of the MSAA hint.
+        constexpr static float SUPERSAMPLE = 2.0f;
+
+        RenderTexture2D _cache{};
+
+        uint64_t _cached_mask = 0;
+        uint64_t _cached_position = 0;
+        bool _cached_turn = true;
 
     public:
 
@@ -204,6 +242,13 @@ namespace connect_four
             : _state(state)
         { }
 
+        void unload() noexcept
+        {
+            if (_cache.id != 0) UnloadRenderTexture(_cache);
+
+            _cache = {};
+        }
+
         void draw() noexcept
         {
             auto& bs = _state.board;
@@ -220,7 +265,68 @@ namespace connect_four
 
             float circle_radius = 0.4f * std::min(block_width, block_height);
 
-            DrawRectangleRec(board, _state.colors.board);
+            if (is_cache_stale(board)) redraw_cache(board, block_width, block_height, circle_radius);
+
+            Rectangle source = { 0, 0, (float)_cache.texture.width, -(float)_cache.texture.height };
+
+            DrawTexturePro(_cache.texture, source, board, { 0, 0 }, 0, WHITE);
+
+            if (!_state.is_playing() || !CheckCollisionPointRec(_state.mouse_location, board)) return;
+
+            uint8_t column = std::min<uint8_t>((_state.mouse_location.x - board.x) / block_width, bs.COLUMNS - 1);
+
+            if (!bs.can_push(column)) return;
+
+            _state.is_hovering = true;
+
+            Vector2 center =
+            {
+                board.x + block_width * (0.5f + column),
+                board.y + block_height * (0.5f + bs.ROWS - bs.column_height(column) - 1)
+            };
+
+            auto color = bs.turn_player_one ? _state.colors.player_one : _state.colors.player_two;
+
+            color.a = 100;
+
+            DrawCircleV(center, circle_radius, color);
+
+            if (_state.is_left_click) _state.emplace(column);
+        }
+
+    private:
+
+        [[nodiscard]] bool is_cache_stale(const Rectangle& board) const noexcept
+        {
+            auto& bs = _state.board;
+
+            return _cache.id == 0
+                || _cache.texture.width != (int)(board.width * SUPERSAMPLE) || _cache.texture.height != (int)(board.height * SUPERSAMPLE)
+                || _cached_mask != bs.mask || _cached_position != bs.current_position || _cached_turn != bs.turn_player_one;
+        }
+
+        void redraw_cache(const Rectangle& board, float block_width, float block_height, float circle_radius) noexcept
+        {
+            TRACE_SCOPE("board_cache");
+
+            auto& bs = _state.board;
+
+            if (_cache.texture.width != (int)(board.width * SUPERSAMPLE) || _cache.texture.height != (int)(board.height * SUPERSAMPLE))
+            {
+                unload();
+
+                _cache = LoadRenderTexture(board.width * SUPERSAMPLE, board.height * SUPERSAMPLE);
+
+                SetTextureFilter(_cache.texture, TEXTURE_FILTER_BILINEAR);
+            }
+
+            _cached_mask = bs.mask;
+            _cached_position = bs.current_position;
+            _cached_turn = bs.turn_player_one;
+
+            BeginTextureMode(_cache);
+
+            ClearBackground(_state.colors.board);
 
             for (uint32_t column_offset = 0; column_offset < bs.COLUMNS; ++column_offset)
             {
@@ -230,45 +336,21 @@ namespace connect_four
 
                     Vector2 center =
                     {
-                        board.x + block_width * (0.5f + column_offset),
-                        board.y + block_height * (0.5f + row_offset)
+                        SUPERSAMPLE * block_width * (0.5f + column_offset),
+                        SUPERSAMPLE * block_height * (0.5f + row_offset)
                     };
 
                     DrawCircleV
                     (
                         center
-                        , circle_radius
+                        , SUPERSAMPLE * circle_radius
                         , slot_state == SlotState::EMPTY ? _state.colors.background :
                           slot_state == SlotState::PLAYER_ONE ? _state.colors.player_one : _state.colors.player_two
                     );
-
-                    Rectangle block =
-                    {
-                        board.x + block_width * column_offset,
-                        board.y,
-                        block_width,
-                        board.height
-                    };
-
-                    if
-                    (
-                        _state.is_playing()
-                        && _state.board.column_height(column_offset) == bs.ROWS - row_offset - 1
-                        && CheckCollisionPointRec(_state.mouse_location, block)
-                    )
-                    {
-                        _state.is_hovering = true;
-
-                        auto color = _state.board.turn_player_one ? _state.colors.player_one : _state.colors.player_two;
-
-                        color.a = 100;
-
-                        DrawCircleV(center, circle_radius, color);
-
-                        if (_state.is_left_click) _state.emplace(column_offset);
-                    }
                 }
             }
+
+            EndTextureMode();
         }
     };
 }
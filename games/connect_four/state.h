@@ -51,6 +51,7 @@ namespace connect_four
         void seed(Span<const uint8_t> moves) noexcept;
 
         [[nodiscard]] bool is_tie() const noexcept;
+        [[nodiscard]] uint64_t key() const noexcept;
         [[nodiscard]] int32_t score() const noexcept;
         [[nodiscard]] bool has_winner() const noexcept;
         [[nodiscard]] bool can_push(uint8_t column) const noexcept;
@@ -109,6 +110,11 @@ namespace connect_four
         return ROWS - column_remaining[column];
     }
 
+    uint64_t BoardState::key() const noexcept
+    {
+        return current_position + mask;
+    }
+
     bool BoardState::is_tie() const noexcept
     {
         return ROWS * COLUMNS == moves_played - 1;
@@ -2,10 +2,15 @@
 // Created by nik on 11/7/2024.
 //
 
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <filesystem>
 #include <gtest/gtest.h>
 
 #include "state.h"
 #include "agent.h"
+#include "analysis.h"
 
 using namespace connect_four;
 
@@ -76,3 +81,260 @@ TEST(connect_four, next_move_prevent_one_lossdfsdasds)
 
 //    ASSERT_TRUE(next_move == 3 || next_move == 4);
 }
+
+TEST(connect_four, transposition_table_preserves_score)
+{
+    auto bs = BoardState();
+    auto table = TranspositionTable(16);
+
+    auto agent = MinimaxAgent(bs);
+    auto cached_agent = MinimaxAgent(bs, &table);
+
+    bs.seed({3, 2, 3, 3, 2});
+
+    auto next_move = agent.next_move();
+
+    ASSERT_EQ(next_move, cached_agent.next_move());
+    ASSERT_EQ(agent.score(), cached_agent.score());
+}
+
+TEST(connect_four, search_config_finds_win)
+{
+    for (uint8_t disabled = 0; disabled <= 5; ++disabled)
+    {
+        auto bs = BoardState();
+        auto table = TranspositionTable(16);
+
+        SearchConfig config;
+
+        config.iterative_deepening = disabled != 1;
+        config.killer_moves = disabled != 2;
+        config.history = disabled != 3;
+        config.aspiration_windows = disabled != 4;
+        config.late_move_reductions = disabled != 5;
+
+        auto agent = MinimaxAgent(bs, &table, config);
+
+        bs.seed({0, 1, 0, 1, 0, 1});
+
+        ASSERT_EQ(agent.next_move(), 0);
+    }
+}
+
+TEST(connect_four, transposition_table_snapshot)
+{
+    auto path = (std::filesystem::temp_directory_path() / "connect_four_cache_test.bin").string();
+
+    auto bs = BoardState();
+    auto table = TranspositionTable(12);
+
+    bs.seed({3, 2, 3, 3, 2});
+
+    table.store(bs.key(), { 17, 4, 3, Bound::EXACT });
+
+    ASSERT_TRUE(table.save(path.c_str()));
+
+    auto loaded = TranspositionTable(12, path.c_str());
+    TranspositionEntry entry;
+
+    ASSERT_TRUE(loaded.is_restored());
+    ASSERT_TRUE(loaded.probe(bs.key(), entry));
+    ASSERT_EQ(entry.score, 17);
+    ASSERT_EQ(entry.column, 3);
+
+    auto resized = TranspositionTable(13, path.c_str());
+
+    ASSERT_FALSE(resized.is_restored());
+    ASSERT_FALSE(resized.probe(bs.key(), entry));
+
+    resized.store(bs.key(), { 17, 4, 3, Bound::EXACT });
+
+    ASSERT_TRUE(resized.probe(bs.key(), entry));
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+
+        for (uint64_t slot = 0; slot < table.size(); ++slot)
+        {
+            file.seekp(16 + 16 * slot + 3);
+            file.put(0x5a);
+        }
+    }
+
+    auto damaged = TranspositionTable(12, path.c_str());
+
+    ASSERT_TRUE(damaged.is_restored());
+    ASSERT_FALSE(damaged.probe(bs.key(), entry));
+
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+
+        file.seekp(8);
+        file.put(0x7f);
+    }
+
+    auto stale = TranspositionTable(12, path.c_str());
+
+    ASSERT_FALSE(stale.is_restored());
+    ASSERT_FALSE(stale.probe(bs.key(), entry));
+
+    std::filesystem::remove(path);
+}
+
+TEST(connect_four, parse_game_rejects_out_of_range_columns)
+{
+    std::vector<uint8_t> moves;
+
+    ASSERT_TRUE(parse_game("3, 2 3\r", moves));
+    ASSERT_EQ(moves, (std::vector<uint8_t>{3, 2, 3}));
+
+    ASSERT_FALSE(parse_game("3237", moves));
+    ASSERT_FALSE(parse_game("32a3", moves));
+    ASSERT_FALSE(parse_game("", moves));
+}
+
+TEST(connect_four, analyse_rejects_illegal_games)
+{
+    auto table = TranspositionTable(16);
+    auto analyser = GameAnalyser(table);
+
+    std::vector<MoveAnnotation> annotations;
+
+    ASSERT_TRUE(analyser.analyse({0, 0, 0, 0, 0, 0}, annotations));
+    ASSERT_EQ(annotations.size(), 6);
+
+    ASSERT_FALSE(analyser.analyse({0, 0, 0, 0, 0, 0, 0}, annotations));
+    ASSERT_FALSE(analyser.analyse({0, 1, 0, 1, 0, 1, 0, 1}, annotations));
+}
+
+TEST(connect_four, analyse_flags_blunder)
+{
+    auto table = TranspositionTable(16);
+    auto analyser = GameAnalyser(table);
+
+    std::vector<MoveAnnotation> annotations;
+
+    ASSERT_TRUE(analyser.analyse({0, 1, 0, 1, 0, 6}, annotations));
+
+    ASSERT_EQ(annotations.back().best, 0);
+    ASSERT_GT(annotations.back().error, 0);
+}
+
+TEST(connect_four, analyse_logs_writes_one_line_per_game)
+{
+    auto table = TranspositionTable(16);
+
+    std::istringstream input("010106\n0000000\n9\n");
+    std::ostringstream output;
+
+    auto report = analyse_logs(input, output, table, 2);
+    auto summary = output.str();
+
+    ASSERT_EQ(report.games, 3);
+    ASSERT_EQ(report.invalid, 2);
+    ASSERT_EQ(report.positions, 6);
+    ASSERT_EQ(std::count(summary.begin(), summary.end(), '\n'), 3);
+}
+
+TEST(connect_four, search_config_preserves_score)
+{
+    std::vector<std::vector<uint8_t>> positions = {{3, 2, 3, 3, 2}, {3, 3, 4, 2}, {0, 6, 3, 3, 4, 5, 2}, {3, 4, 3, 4, 2, 2, 5}};
+
+    SearchConfig plain;
+
+    plain.iterative_deepening = plain.killer_moves = plain.history = false;
+    plain.aspiration_windows = plain.late_move_reductions = false;
+
+    uint64_t plain_nodes = 0, ordered_nodes = 0, reduced_nodes = 0;
+
+    for (auto& moves : positions)
+    {
+        auto bs = BoardState();
+
+        for (uint8_t column : moves) bs.push(column);
+
+        auto reference = MinimaxAgent(bs, nullptr, plain);
+
+        reference.next_move();
+        plain_nodes += reference.nodes();
+
+        for (uint8_t features = 1; features < 16; ++features)
+        {
+            SearchConfig config = plain;
+
+            config.iterative_deepening = features & 1;
+            config.killer_moves = features & 2;
+            config.history = features & 4;
+            config.aspiration_windows = features & 8;
+
+            auto agent = MinimaxAgent(bs, nullptr, config);
+
+            agent.next_move();
+
+            ASSERT_EQ(agent.score(), reference.score());
+
+            if (features == 15) ordered_nodes += agent.nodes();
+        }
+
+        auto reduced = MinimaxAgent(bs);
+
+        reduced.next_move();
+        reduced_nodes += reduced.nodes();
+    }
+
+    ASSERT_LT(ordered_nodes, plain_nodes);
+    ASSERT_LT(reduced_nodes, ordered_nodes);
+}
+
+TEST(connect_four, analyse_error_matches_full_depth_scores)
+{
+    std::mt19937 random(11);
+
+    SearchConfig full_depth;
+
+    full_depth.late_move_reductions = false;
+
+    for (uint32_t game = 0; game < 10; ++game)
+    {
+        auto bs = BoardState();
+
+        std::vector<uint8_t> moves;
+
+        while (moves.size() < 12 && !bs.has_winner())
+        {
+            uint8_t column;
+
+            do column = random() % BoardState::COLUMNS; while (!bs.can_push(column));
+
+            bs.push(column), moves.push_back(column);
+        }
+
+        if (bs.has_winner()) continue;
+
+        auto table = TranspositionTable(16);
+        auto analyser = GameAnalyser(table);
+
+        std::vector<MoveAnnotation> annotations;
+
+        ASSERT_TRUE(analyser.analyse(moves, annotations));
+
+        auto reference_state = BoardState();
+        auto reference = MinimaxAgent(reference_state, nullptr, full_depth);
+
+        for (uint32_t ply = 0; ply < annotations.size(); ++ply)
+        {
+            auto& annotation = annotations[ply];
+
+            if (annotation.best != annotation.played)
+            {
+                int32_t best = reference.evaluate(annotation.best), played = reference.evaluate(annotation.played);
+
+                ASSERT_GE(best, played);
+
+                if (best != played) ASSERT_GT(annotation.error, 0);
+            }
+
+            reference_state.push(moves[ply]);
+        }
+    }
+}
@@ -0,0 +1,246 @@
+#ifndef AIGAMES_TRANSPOSITION_H
+#define AIGAMES_TRANSPOSITION_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace connect_four
+{
+    enum class Bound : uint8_t
+    {
+        NONE, EXACT, LOWER, UPPER
+    };
+
+    struct TranspositionEntry
+    {
+        int32_t score = 0;
+        uint8_t depth = 0;
+        uint8_t column = 0;
+        Bound bound = Bound::NONE;
+    };
+
+    // Lossy, lock-free table shared between agents. Each slot is two words: the packed entry and the key xor'd
+    // with it, so a torn write from a concurrent store fails the key check and is treated as a miss.
+    class TranspositionTable
+    {
+        constexpr static uint64_t SNAPSHOT_MAGIC = UINT64_C(0x3452554F46434941);
+        constexpr static uint32_t SNAPSHOT_VERSION = 2;
+
+        // Bump SNAPSHOT_VERSION whenever the entry packing, key or scoring changes so older snapshots are dropped.
+        struct SnapshotHeader
+        {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t size_log2;
+        };
+
+        uint8_t _size_log2;
+        uint64_t _mask;
+        uint64_t* _slots = nullptr;
+        std::unique_ptr<uint64_t[]> _owned;
+
+        void* _mapping = nullptr;
+        uint64_t _mapping_size = 0;
+        bool _restored = false;
+
+    public:
+
+        // With a snapshot path the table is restored from that file when it is valid, and only allocated and
+        // zeroed when it is not.
+        explicit TranspositionTable(uint8_t size_log2 = 20, const char* snapshot = nullptr)
+            : _size_log2(size_log2)
+            , _mask((UINT64_C(1) << size_log2) - 1)
+        {
+            if (snapshot && load(snapshot)) return;
+
+            _owned.reset(new uint64_t[2 * size()]());
+            _slots = _owned.get();
+        }
+
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        ~TranspositionTable();
+
+        void clear() noexcept;
+        void store(uint64_t key, const TranspositionEntry& entry) noexcept;
+
+        bool load(const char* path) noexcept;
+        bool save(const char* path) const noexcept;
+
+        [[nodiscard]] bool is_restored() const noexcept { return _restored; }
+
+        [[nodiscard]] uint64_t size() const noexcept { return _mask + 1; }
+        [[nodiscard]] bool probe(uint64_t key, TranspositionEntry& entry) const noexcept;
+
+    private:
+
+        void unmap() noexcept;
+
+        [[nodiscard]] uint64_t index(uint64_t key) const noexcept;
+        [[nodiscard]] uint64_t payload_size() const noexcept { return 2 * size() * sizeof(uint64_t); }
+        [[nodiscard]] SnapshotHeader snapshot_header() const noexcept;
+    };
+
+    TranspositionTable::~TranspositionTable()
+    {
+        unmap();
+    }
+
+    void TranspositionTable::unmap() noexcept
+    {
+#ifndef _WIN32
+        if (_mapping) munmap(_mapping, _mapping_size);
+#endif
+        _mapping = nullptr, _mapping_size = 0;
+    }
+
+    TranspositionTable::SnapshotHeader TranspositionTable::snapshot_header() const noexcept
+    {
+        return { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, _size_log2 };
+    }
+
+    // The file is the header followed by the raw slots, written to a temporary and renamed over the old snapshot
+    // so a crash mid-write never leaves a truncated file behind.
+    bool TranspositionTable::save(const char* path) const noexcept
+    {
+        std::string temporary = std::string(path) + ".tmp";
+
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+
+            SnapshotHeader header = snapshot_header();
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(_slots), payload_size());
+        }
+
+        std::error_code error;
+
+        if (std::filesystem::file_size(temporary, error) != sizeof(SnapshotHeader) + payload_size() || error)
+        {
+            std::filesystem::remove(temporary, error); return false;
+        }
+
+        std::filesystem::rename(temporary, path, error);
+
+        return !error;
+    }
+
+    // Adopts a snapshot only if its size, magic, version and geometry all match; anything else leaves the table
+    // untouched. The slots are mapped copy-on-write rather than read, so startup does not grow with the file. There
+    // is no payload checksum for the same reason: each slot already validates itself against its key on probe, so
+    // a damaged slot reads as a miss.
+    bool TranspositionTable::load(const char* path) noexcept
+    {
+        SnapshotHeader expected = snapshot_header(), header{};
+
+        std::error_code error;
+
+        if (std::filesystem::file_size(path, error) != sizeof(header) + payload_size() || error) return false;
+
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+
+        in.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+        if (!in || std::memcmp(&header, &expected, sizeof(header)) != 0) return false;
+
+        auto slots = std::unique_ptr<uint64_t[]>(new uint64_t[2 * size()]);
+
+        if (!in.read(reinterpret_cast<char*>(slots.get()), payload_size())) return false;
+
+        _owned = std::move(slots);
+        _slots = _owned.get();
+        _restored = true;
+#else
+        int file = open(path, O_RDONLY);
+
+        if (file < 0) return false;
+
+        if (pread(file, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || std::memcmp(&header, &expected, sizeof(header)) != 0)
+        {
+            close(file); return false;
+        }
+
+        void* mapping = mmap(nullptr, sizeof(header) + payload_size(), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+
+        close(file);
+
+        if (mapping == MAP_FAILED) return false;
+
+        unmap();
+
+        _mapping = mapping;
+        _mapping_size = sizeof(header) + payload_size();
+
+        _slots = reinterpret_cast<uint64_t*>(static_cast<char*>(mapping) + sizeof(header));
+        _owned.reset();
+        _restored = true;
+#endif
+        return true;
+    }
+
+    uint64_t TranspositionTable::index(uint64_t key) const noexcept
+    {
+        key ^= key >> 33;
+        key *= UINT64_C(0xff51afd7ed558ccd);
+        key ^= key >> 33;
+
+        return 2 * (key & _mask);
+    }
+
+    void TranspositionTable::store(uint64_t key, const TranspositionEntry& entry) noexcept
+    {
+        uint64_t data = static_cast<uint32_t>(entry.score)
+            | static_cast<uint64_t>(entry.depth) << 32
+            | static_cast<uint64_t>(entry.column) << 40
+            | static_cast<uint64_t>(entry.bound) << 48;
+
+        uint64_t slot = index(key);
+
+        std::atomic_ref<uint64_t>(_slots[slot]).store(key ^ data, std::memory_order_relaxed);
+        std::atomic_ref<uint64_t>(_slots[slot + 1]).store(data, std::memory_order_relaxed);
+    }
+
+    bool TranspositionTable::probe(uint64_t key, TranspositionEntry& entry) const noexcept
+    {
+        uint64_t slot = index(key);
+
+        uint64_t check = std::atomic_ref<uint64_t>(_slots[slot]).load(std::memory_order_relaxed);
+        uint64_t data = std::atomic_ref<uint64_t>(_slots[slot + 1]).load(std::memory_order_relaxed);
+
+        if ((check ^ data) != key) return false;
+
+        entry.bound = static_cast<Bound>(data >> 48);
+
+        if (entry.bound == Bound::NONE) return false;
+
+        entry.score = static_cast<int32_t>(static_cast<uint32_t>(data));
+        entry.depth = static_cast<uint8_t>(data >> 32);
+        entry.column = static_cast<uint8_t>(data >> 40);
+
+        return true;
+    }
+
+    void TranspositionTable::clear() noexcept
+    {
+        for (uint64_t slot = 0; slot < 2 * size(); ++slot)
+        {
+            std::atomic_ref<uint64_t>(_slots[slot]).store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif //AIGAMES_TRANSPOSITION_H
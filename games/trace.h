@@ -0,0 +1,197 @@
+#ifndef AIGAMES_TRACE_H
+#define AIGAMES_TRACE_H
+
+// Scoped timeline tracing, dumped as Chrome trace_event JSON (chrome://tracing, ui.perfetto.dev). Everything below
+// only exists when AIGAMES_TRACE is defined; otherwise the macros expand to nothing and cost nothing.
+
+#ifdef AIGAMES_TRACE
+
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+
+namespace trace
+{
+    enum class Phase : char
+    {
+        COMPLETE = 'X', COUNTER = 'C'
+    };
+
+    struct Event
+    {
+        const char* name;
+        uint64_t start;
+        uint64_t duration;
+        int64_t value;
+        Phase phase;
+    };
+
+    // Single producer ring owned by one thread; the oldest events are overwritten once it wraps. Readers copy
+    // out of it without blocking the writer and drop whatever the writer may have lapped while they were copying.
+    // The copy itself is not atomic, so a dump is only exact while the writers are quiescent; both callers dump
+    // from a point where they are (the game from its only writing thread, the analysis tool after joining).
+    class RingBuffer
+    {
+        constexpr static uint64_t CAPACITY = 1 << 14;
+
+        uint32_t _thread;
+        std::atomic<uint64_t> _head = 0;
+        std::unique_ptr<Event[]> _events;
+
+    public:
+
+        explicit RingBuffer(uint32_t thread)
+            : _thread(thread), _events(new Event[CAPACITY])
+        { }
+
+        void push(const Event& event) noexcept;
+        void snapshot(std::vector<Event>& events) const;
+
+        [[nodiscard]] uint32_t thread() const noexcept { return _thread; }
+    };
+
+    void RingBuffer::push(const Event& event) noexcept
+    {
+        uint64_t head = _head.load(std::memory_order_relaxed);
+
+        _events[head % CAPACITY] = event;
+
+        _head.store(head + 1, std::memory_order_release);
+    }
+
+    void RingBuffer::snapshot(std::vector<Event>& events) const
+    {
+        events.clear();
+
+        uint64_t head = _head.load(std::memory_order_acquire);
+        uint64_t first = head > CAPACITY ? head - CAPACITY : 0;
+
+        for (uint64_t index = first; index < head; ++index) events.push_back(_events[index % CAPACITY]);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        uint64_t lapped = _head.load(std::memory_order_acquire);
+
+        if (lapped + 1 > first + CAPACITY)
+        {
+            uint64_t stale = std::min<uint64_t>(lapped + 1 - first - CAPACITY, events.size());
+
+            events.erase(events.begin(), events.begin() + stale);
+        }
+    }
+
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::unique_ptr<RingBuffer>> buffers;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    inline Registry registry;
+
+    // Registration takes the lock once per thread; every event after that only touches the thread's own ring.
+    inline RingBuffer& local_buffer()
+    {
+        thread_local RingBuffer* buffer = nullptr;
+
+        if (buffer) return *buffer;
+
+        std::lock_guard lock(registry.lock);
+
+        registry.buffers.push_back(std::make_unique<RingBuffer>(registry.buffers.size()));
+
+        return *(buffer = registry.buffers.back().get());
+    }
+
+    inline uint64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry.epoch).count();
+    }
+
+    class Scope
+    {
+        const char* _name;
+        uint64_t _start;
+
+    public:
+
+        explicit Scope(const char* name) noexcept
+            : _name(name), _start(now())
+        { }
+
+        ~Scope()
+        {
+            local_buffer().push({ _name, _start, now() - _start, 0, Phase::COMPLETE });
+        }
+    };
+
+    inline void counter(const char* name, int64_t value)
+    {
+        local_buffer().push({ name, now(), 0, value, Phase::COUNTER });
+    }
+
+    inline bool dump(const char* path)
+    {
+        std::ofstream out(path);
+
+        if (!out) return false;
+
+        std::vector<Event> events;
+
+        std::lock_guard lock(registry.lock);
+
+        out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+
+        bool first = true;
+
+        for (auto& buffer : registry.buffers)
+        {
+            buffer->snapshot(events);
+
+            for (auto& event : events)
+            {
+                out << (first ? "\n" : ",\n") << "{\"name\":\"" << event.name;
+
+                // Counter tracks are merged by process and name, so each thread gets its own series.
+                if (event.phase == Phase::COUNTER) out << " (thread " << buffer->thread() << ")";
+
+                out << "\",\"ph\":\"" << static_cast<char>(event.phase)
+                    << "\",\"pid\":1,\"tid\":" << buffer->thread() << ",\"ts\":" << event.start / 1000.0;
+
+                if (event.phase == Phase::COMPLETE) out << ",\"dur\":" << event.duration / 1000.0 << "}";
+                else out << ",\"args\":{\"value\":" << event.value << "}}";
+
+                first = false;
+            }
+        }
+
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+        return true;
+    }
+}
+
+#define TRACE_CONCAT_INNER(left, right) left##right
+#define TRACE_CONCAT(left, right) TRACE_CONCAT_INNER(left, right)
+
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(_trace_scope_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) trace::counter(name, value)
+#define TRACE_INCREMENT(counter) ++(counter)
+#define TRACE_RESET(counter) (counter) = 0
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_INCREMENT(counter) static_cast<void>(0)
+#define TRACE_RESET(counter) static_cast<void>(0)
+
+#endif
+
+#endif //AIGAMES_TRACE_H